@@ -1,14 +1,19 @@
+// Build with -DMAZE_HEADLESS to drop SDL entirely (no window, no main) and
+// use the maze generator plus render_views() as a library through maze.h.
+#ifndef MAZE_HEADLESS
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
 
-#define WALL 0
-#define PATH 1
-#define EXIT_TILE 2
-#define MAP_PIECE 3
+#include "maze.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 #define MAP_W 101
 #define MAP_H 101
@@ -18,9 +23,20 @@
 
 #define FOV (M_PI / 3.0)
 
-#define NUM_ROOMS 44
+// Grayscale levels for offscreen views (luma of the SDL palette)
+#define GRAY_CEILING 65
+#define GRAY_FLOOR 42
+#define GRAY_WALL_LIT 220
+#define GRAY_WALL_SHADED 140
+#define GRAY_EXIT 161
+#define GRAY_MAP_PIECE 147
+
 #define MIN_ROOM_SIZE 4
 #define MAX_ROOM_SIZE 23
+#define ROOM_PAD 3
+#define ROOM_PLACE_ATTEMPTS (NUM_ROOMS * 12)
+#define ROOM_BUCKET_SIZE (MAX_ROOM_SIZE + ROOM_PAD)
+#define ROOM_LINK_NEIGHBORS 3
 
 #define MINIMAP_SIZE 300
 #define MINIMAP_MIN_ZOOM 1
@@ -28,38 +44,73 @@
 #define NUM_MAP_PIECES 3
 #define MAP_REVEAL_RADIUS 55
 
+// Uniform bucket grid over room top-left corners. Buckets are at least as
+// wide as the largest padded room, so overlap tests only touch a few buckets.
 typedef struct {
-    int x, y, w, h;
-} Room;
+    int *head;      // first room index per bucket, -1 if empty
+    int *next;      // next room index in the same bucket
+    int cols, rows;
+} RoomGrid;
 
 typedef struct {
-    int **grid;
-    int **visited;
-    int w, h;
-} Maze;
+    int a, b;
+    int len;
+} RoomLink;
 
+// Result of one DDA ray: the tile it stopped on and how far away it was.
+typedef struct {
+    int map_x, map_y;
+    int side;
+    int tile;
+    double dist;
+} ColumnHit;
+
+// Everything the last presented frame was drawn from. If none of it changes
+// the frame on screen is still correct and nothing needs to be redrawn.
 typedef struct {
-    double x, y;
-    double dir;
-    double dir_x, dir_y;
-    double plane_x, plane_y;
-} Player;
-
-int minimap_zoom = 12;
-int current_level = 1;
-
-void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms);
-void free_maze(Maze *maze);
-void generate_maze(Maze *maze, int cx, int cy);
-void draw_minimap(SDL_Renderer *ren, Maze *maze, Player *player, int map_size);
-void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_map);
-void regenerate_maze(Maze *maze, Room *rooms, Player *player);
-void reveal_random_distant_patch(Maze *maze, int piece_x, int piece_y);
-void draw_hud(SDL_Renderer *ren, TTF_Font *font);
-
-void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms) {
+    int valid;
+    double x, y, dir;
+    int show_map;
+    int zoom;
+    int level;
+    int revision;
+} ViewCache;
+
+#ifndef MAZE_HEADLESS
+static int minimap_zoom = 12;
+static int current_level = 1;
+static ColumnHit column_hits[SCREEN_W];
+#endif
+
+static void room_grid_init(RoomGrid *g, int map_w, int map_h, int max_rooms);
+static void room_grid_free(RoomGrid *g);
+static void room_grid_insert(RoomGrid *g, Room *rooms, int i);
+static int room_grid_overlaps(RoomGrid *g, Room *rooms, int x, int y, int w, int h);
+static void carve_corridor(Maze *maze, int x1, int y1, int x2, int y2);
+static int compare_room_links(const void *a, const void *b);
+static int find_room_set(int *parent, int i);
+static int nearest_foreign_room(RoomGrid *g, Room *rooms, int *parent, int i, int *out_len);
+static int bridge_room_sets(Maze *maze, Room *rooms, int num_rooms, RoomGrid *g, int *parent);
+static void connect_rooms(Maze *maze, Room *rooms, int num_rooms);
+static void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms);
+static void generate_maze(Maze *maze, int cx, int cy);
+static void cast_ray(const Maze *maze, double pos_x, double pos_y, double ray_dir_x, double ray_dir_y,
+                     int **reveal, ColumnHit *hit);
+#ifndef MAZE_HEADLESS
+static void reveal_random_distant_patch(Maze *maze, int piece_x, int piece_y);
+static void cast_columns(Maze *maze, Player *player, ColumnHit *hits);
+static void draw_minimap(SDL_Renderer *ren, Maze *maze, Player *player, int map_size);
+static void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_map, int recast);
+static int view_moved(ViewCache *view, Maze *maze, Player *player);
+static int overlay_changed(ViewCache *view, int show_map);
+static void view_store(ViewCache *view, Maze *maze, Player *player, int show_map);
+static void draw_hud(SDL_Renderer *ren, TTF_Font *font);
+#endif
+
+void init_maze(Maze *maze) {
     maze->w = MAP_W;
     maze->h = MAP_H;
+    maze->revision = 0;
     maze->grid = malloc(maze->h * sizeof(int*));
     maze->visited = malloc(maze->h * sizeof(int*));
     for (int y = 0; y < maze->h; y++) {
@@ -70,10 +121,22 @@ void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms) {
             maze->visited[y][x] = 0;
         }
     }
+}
+
+static void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms) {
+    for (int y = 0; y < maze->h; y++) {
+        for (int x = 0; x < maze->w; x++) {
+            maze->grid[y][x] = WALL;
+            maze->visited[y][x] = 0;
+        }
+    }
 
     *num_rooms = 0;
 
-    for (int attempts = 0; attempts < 500 && *num_rooms < NUM_ROOMS; attempts++) {
+    RoomGrid g;
+    room_grid_init(&g, maze->w, maze->h, NUM_ROOMS);
+
+    for (int attempts = 0; attempts < ROOM_PLACE_ATTEMPTS && *num_rooms < NUM_ROOMS; attempts++) {
         int w = MIN_ROOM_SIZE + rand() % (MAX_ROOM_SIZE - MIN_ROOM_SIZE + 1);
         int h = MIN_ROOM_SIZE + rand() % (MAX_ROOM_SIZE - MIN_ROOM_SIZE + 1);
         if (w % 2 == 0) w++;
@@ -82,16 +145,7 @@ void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms) {
         int x = rand() % (maze->w - w - 6) + 3;
         int y = rand() % (maze->h - h - 6) + 3;
 
-        int overlap = 0;
-        for (int j = 0; j < *num_rooms; j++) {
-            Room r = rooms[j];
-            if (!(x + w + 3 <= r.x || x >= r.x + r.w + 3 ||
-                  y + h + 3 <= r.y || y >= r.y + r.h + 3)) {
-                overlap = 1;
-                break;
-            }
-        }
-        if (overlap) continue;
+        if (room_grid_overlaps(&g, rooms, x, y, w, h)) continue;
 
         for (int ry = y; ry < y + h; ry++) {
             for (int rx = x; rx < x + w; rx++) {
@@ -99,8 +153,284 @@ void init_maze_with_rooms(Maze *maze, Room *rooms, int *num_rooms) {
             }
         }
 
-        rooms[(*num_rooms)++] = (Room){x, y, w, h};
+        rooms[*num_rooms] = (Room){x, y, w, h};
+        room_grid_insert(&g, rooms, *num_rooms);
+        (*num_rooms)++;
+    }
+
+    room_grid_free(&g);
+}
+
+static void room_grid_init(RoomGrid *g, int map_w, int map_h, int max_rooms) {
+    g->cols = map_w / ROOM_BUCKET_SIZE + 1;
+    g->rows = map_h / ROOM_BUCKET_SIZE + 1;
+    g->head = malloc(g->cols * g->rows * sizeof(int));
+    g->next = malloc(max_rooms * sizeof(int));
+    for (int i = 0; i < g->cols * g->rows; i++) {
+        g->head[i] = -1;
+    }
+}
+
+static void room_grid_free(RoomGrid *g) {
+    free(g->head);
+    free(g->next);
+}
+
+static void room_grid_insert(RoomGrid *g, Room *rooms, int i) {
+    int b = (rooms[i].y / ROOM_BUCKET_SIZE) * g->cols + rooms[i].x / ROOM_BUCKET_SIZE;
+    g->next[i] = g->head[b];
+    g->head[b] = i;
+}
+
+static int room_grid_overlaps(RoomGrid *g, Room *rooms, int x, int y, int w, int h) {
+    // A room can only conflict if its corner lies within one padded max-size
+    // room to the left/above, or inside the candidate's padded extent.
+    int bx0 = (x - ROOM_BUCKET_SIZE) / ROOM_BUCKET_SIZE;
+    int by0 = (y - ROOM_BUCKET_SIZE) / ROOM_BUCKET_SIZE;
+    int bx1 = (x + w + ROOM_PAD) / ROOM_BUCKET_SIZE;
+    int by1 = (y + h + ROOM_PAD) / ROOM_BUCKET_SIZE;
+    if (bx0 < 0) bx0 = 0;
+    if (by0 < 0) by0 = 0;
+    if (bx1 >= g->cols) bx1 = g->cols - 1;
+    if (by1 >= g->rows) by1 = g->rows - 1;
+
+    for (int by = by0; by <= by1; by++) {
+        for (int bx = bx0; bx <= bx1; bx++) {
+            for (int j = g->head[by * g->cols + bx]; j >= 0; j = g->next[j]) {
+                Room r = rooms[j];
+                if (!(x + w + ROOM_PAD <= r.x || x >= r.x + r.w + ROOM_PAD ||
+                      y + h + ROOM_PAD <= r.y || y >= r.y + r.h + ROOM_PAD)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static void carve_corridor(Maze *maze, int x1, int y1, int x2, int y2) {
+    int x = x1, y = y1;
+    while (x != x2) {
+        maze->grid[y][x] = PATH;
+        x += (x < x2) ? 1 : -1;
     }
+    while (y != y2) {
+        maze->grid[y][x] = PATH;
+        y += (y < y2) ? 1 : -1;
+    }
+}
+
+static int compare_room_links(const void *a, const void *b) {
+    return ((const RoomLink *)a)->len - ((const RoomLink *)b)->len;
+}
+
+static int find_room_set(int *parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Nearest room (by centre distance) that is not already connected to room i,
+// or -1 if every room is in i's set.
+static int nearest_foreign_room(RoomGrid *g, Room *rooms, int *parent, int i, int *out_len) {
+    int cx = rooms[i].x + rooms[i].w / 2;
+    int cy = rooms[i].y + rooms[i].h / 2;
+    int bx = rooms[i].x / ROOM_BUCKET_SIZE;
+    int by = rooms[i].y / ROOM_BUCKET_SIZE;
+    int set = find_room_set(parent, i);
+
+    int best = -1;
+    int best_len = 0;
+
+    int max_ring = g->cols > g->rows ? g->cols : g->rows;
+    int stop_ring = max_ring;
+    for (int ring = 0; ring <= stop_ring; ring++) {
+        for (int y = by - ring; y <= by + ring; y++) {
+            for (int x = bx - ring; x <= bx + ring; x++) {
+                if (x < 0 || x >= g->cols || y < 0 || y >= g->rows) continue;
+                if (abs(x - bx) != ring && abs(y - by) != ring) continue;
+
+                for (int j = g->head[y * g->cols + x]; j >= 0; j = g->next[j]) {
+                    if (find_room_set(parent, j) == set) continue;
+                    int len = abs(rooms[j].x + rooms[j].w / 2 - cx) +
+                              abs(rooms[j].y + rooms[j].h / 2 - cy);
+                    if (best < 0 || len < best_len) {
+                        best = j;
+                        best_len = len;
+                    }
+                }
+            }
+        }
+        if (best >= 0 && stop_ring == max_ring) {
+            stop_ring = ring + 1;
+        }
+    }
+
+    *out_len = best_len;
+    return best;
+}
+
+// One Boruvka round over the components left after Kruskal: every component
+// except the largest gets its shortest link to another component. Returns
+// how many links were carved.
+static int bridge_room_sets(Maze *maze, Room *rooms, int num_rooms, RoomGrid *g, int *parent) {
+    int *size = calloc(num_rooms, sizeof(int));
+    int *from = malloc(num_rooms * sizeof(int));
+    int *to = malloc(num_rooms * sizeof(int));
+    int *len = malloc(num_rooms * sizeof(int));
+
+    int largest = find_room_set(parent, 0);
+    for (int i = 0; i < num_rooms; i++) {
+        int r = find_room_set(parent, i);
+        size[r]++;
+        if (size[r] > size[largest]) largest = r;
+        from[i] = -1;
+    }
+
+    // Only the small components search, so this stays cheap even when the
+    // main component holds almost every room.
+    for (int i = 0; i < num_rooms; i++) {
+        int r = find_room_set(parent, i);
+        if (r == largest) continue;
+
+        int l;
+        int j = nearest_foreign_room(g, rooms, parent, i, &l);
+        if (j >= 0 && (from[r] < 0 || l < len[r])) {
+            from[r] = i;
+            to[r] = j;
+            len[r] = l;
+        }
+    }
+
+    int merged = 0;
+    for (int r = 0; r < num_rooms; r++) {
+        if (from[r] < 0) continue;
+        int a = find_room_set(parent, from[r]);
+        int b = find_room_set(parent, to[r]);
+        if (a == b) continue;
+        parent[a] = b;
+        merged++;
+
+        Room ra = rooms[from[r]];
+        Room rb = rooms[to[r]];
+        carve_corridor(maze, ra.x + ra.w / 2, ra.y + ra.h / 2,
+                       rb.x + rb.w / 2, rb.y + rb.h / 2);
+    }
+
+    free(size);
+    free(from);
+    free(to);
+    free(len);
+    return merged;
+}
+
+static void connect_rooms(Maze *maze, Room *rooms, int num_rooms) {
+    if (num_rooms < 2) return;
+
+    RoomGrid g;
+    room_grid_init(&g, maze->w, maze->h, num_rooms);
+    for (int i = 0; i < num_rooms; i++) {
+        room_grid_insert(&g, rooms, i);
+    }
+
+    // Candidate links: each room to its few nearest neighbours, found by
+    // searching outward ring by ring through the bucket grid.
+    RoomLink *links = malloc(num_rooms * ROOM_LINK_NEIGHBORS * sizeof(RoomLink));
+    int num_links = 0;
+
+    for (int i = 0; i < num_rooms; i++) {
+        int cx = rooms[i].x + rooms[i].w / 2;
+        int cy = rooms[i].y + rooms[i].h / 2;
+        int bx = rooms[i].x / ROOM_BUCKET_SIZE;
+        int by = rooms[i].y / ROOM_BUCKET_SIZE;
+
+        int best[ROOM_LINK_NEIGHBORS];
+        int best_len[ROOM_LINK_NEIGHBORS];
+        int found = 0;
+
+        // Keep going one ring past the first hit, since a bucket's corner key
+        // is only an approximation of where the room's centre sits.
+        int max_ring = g.cols > g.rows ? g.cols : g.rows;
+        int stop_ring = max_ring;
+        for (int ring = 0; ring <= stop_ring; ring++) {
+            for (int y = by - ring; y <= by + ring; y++) {
+                for (int x = bx - ring; x <= bx + ring; x++) {
+                    if (x < 0 || x >= g.cols || y < 0 || y >= g.rows) continue;
+                    if (abs(x - bx) != ring && abs(y - by) != ring) continue;
+
+                    for (int j = g.head[y * g.cols + x]; j >= 0; j = g.next[j]) {
+                        if (j == i) continue;
+                        int len = abs(rooms[j].x + rooms[j].w / 2 - cx) +
+                                  abs(rooms[j].y + rooms[j].h / 2 - cy);
+
+                        if (found == ROOM_LINK_NEIGHBORS && best_len[found - 1] <= len) continue;
+
+                        int k = (found < ROOM_LINK_NEIGHBORS) ? found++ : found - 1;
+                        while (k > 0 && best_len[k - 1] > len) {
+                            best[k] = best[k - 1];
+                            best_len[k] = best_len[k - 1];
+                            k--;
+                        }
+                        best[k] = j;
+                        best_len[k] = len;
+                    }
+                }
+            }
+            if (found == ROOM_LINK_NEIGHBORS && stop_ring == max_ring) {
+                stop_ring = ring + 1;
+            }
+        }
+
+        for (int k = 0; k < found; k++) {
+            if (best[k] > i) {
+                links[num_links++] = (RoomLink){i, best[k], best_len[k]};
+            } else {
+                links[num_links++] = (RoomLink){best[k], i, best_len[k]};
+            }
+        }
+    }
+
+    qsort(links, num_links, sizeof(RoomLink), compare_room_links);
+
+    // Kruskal over the neighbour graph gives a minimum spanning forest.
+    int *parent = malloc(num_rooms * sizeof(int));
+    for (int i = 0; i < num_rooms; i++) {
+        parent[i] = i;
+    }
+
+    for (int i = 0; i < num_links; i++) {
+        int a = find_room_set(parent, links[i].a);
+        int b = find_room_set(parent, links[i].b);
+        if (a == b) continue;
+        parent[a] = b;
+
+        Room ra = rooms[links[i].a];
+        Room rb = rooms[links[i].b];
+        carve_corridor(maze, ra.x + ra.w / 2, ra.y + ra.h / 2,
+                       rb.x + rb.w / 2, rb.y + rb.h / 2);
+    }
+
+    // The neighbour graph can leave isolated clusters; bridge each one to its
+    // nearest room elsewhere until only one component remains.
+    while (bridge_room_sets(maze, rooms, num_rooms, &g, parent) > 0) {
+    }
+
+    // Last resort, should bridging ever stall: stitch in index order.
+    for (int i = 1; i < num_rooms; i++) {
+        int a = find_room_set(parent, i);
+        int b = find_room_set(parent, i - 1);
+        if (a == b) continue;
+        parent[a] = b;
+
+        carve_corridor(maze, rooms[i].x + rooms[i].w / 2, rooms[i].y + rooms[i].h / 2,
+                       rooms[i - 1].x + rooms[i - 1].w / 2, rooms[i - 1].y + rooms[i - 1].h / 2);
+    }
+
+    free(parent);
+    free(links);
+    room_grid_free(&g);
 }
 
 void free_maze(Maze *maze) {
@@ -112,7 +442,7 @@ void free_maze(Maze *maze) {
     free(maze->visited);
 }
 
-void generate_maze(Maze *maze, int cx, int cy) {
+static void generate_maze(Maze *maze, int cx, int cy) {
     maze->grid[cy][cx] = PATH;
 
     int dirs[4][2] = {{0,-2},{2,0},{0,2},{-2,0}};
@@ -133,7 +463,8 @@ void generate_maze(Maze *maze, int cx, int cy) {
     }
 }
 
-void reveal_random_distant_patch(Maze *maze, int piece_x, int piece_y) {
+#ifndef MAZE_HEADLESS
+static void reveal_random_distant_patch(Maze *maze, int piece_x, int piece_y) {
     int cx, cy;
     int attempts = 0;
     do {
@@ -158,17 +489,12 @@ void reveal_random_distant_patch(Maze *maze, int piece_x, int piece_y) {
         }
     }
 }
+#endif
 
 void regenerate_maze(Maze *maze, Room *rooms, Player *player) {
-    for (int y = 0; y < maze->h; y++) {
-        for (int x = 0; x < maze->w; x++) {
-            maze->visited[y][x] = 0;
-            maze->grid[y][x] = WALL;
-        }
-    }
-
     int num_rooms = 0;
     init_maze_with_rooms(maze, rooms, &num_rooms);
+    maze->revision++;
 
     if (num_rooms == 0) {
         for (int y = 1; y < 8; y++) {
@@ -203,33 +529,7 @@ void regenerate_maze(Maze *maze, Room *rooms, Player *player) {
         }
     }
 
-    if (num_rooms > 1) {
-        for (int i = num_rooms - 1; i > 0; i--) {
-            int j = rand() % (i + 1);
-            Room temp = rooms[i];
-            rooms[i] = rooms[j];
-            rooms[j] = temp;
-        }
-
-        for (int i = 1; i < num_rooms; i++) {
-            Room a = rooms[i];
-            Room b = rooms[rand() % i];
-            int x1 = a.x + a.w / 2;
-            int y1 = a.y + a.h / 2;
-            int x2 = b.x + b.w / 2;
-            int y2 = b.y + b.h / 2;
-
-            int x = x1, y = y1;
-            while (x != x2) {
-                maze->grid[y][x] = PATH;
-                x += (x < x2) ? 1 : -1;
-            }
-            while (y != y2) {
-                maze->grid[y][x] = PATH;
-                y += (y < y2) ? 1 : -1;
-            }
-        }
-    }
+    connect_rooms(maze, rooms, num_rooms);
 
     for (int i = 0; i < num_rooms; i++) {
         int cx = rooms[i].x + rooms[i].w / 2;
@@ -290,12 +590,19 @@ void regenerate_maze(Maze *maze, Room *rooms, Player *player) {
     player->x = spawn_x + 0.5;
     player->y = spawn_y + 0.5;
     player->dir = M_PI / 2.0;
+    player_set_dir(player);
+}
 
-    // Increment level after successful generation
-    current_level++;
+void player_set_dir(Player *player) {
+    double fov_half_tan = tan(FOV / 2.0);
+    player->dir_x = cos(player->dir);
+    player->dir_y = sin(player->dir);
+    player->plane_x = -player->dir_y * fov_half_tan;
+    player->plane_y = player->dir_x * fov_half_tan;
 }
 
-void draw_minimap(SDL_Renderer *ren, Maze *maze, Player *player, int map_size) {
+#ifndef MAZE_HEADLESS
+static void draw_minimap(SDL_Renderer *ren, Maze *maze, Player *player, int map_size) {
     int margin = 20;
     int map_x = SCREEN_W - map_size - margin;
     int map_y = margin;
@@ -382,47 +689,134 @@ void draw_minimap(SDL_Renderer *ren, Maze *maze, Player *player, int map_size) {
     SDL_SetRenderDrawColor(ren, 255, 255, 0, 255);
     SDL_RenderDrawLine(ren, px, py, dir_end_x, dir_end_y);
 }
+#endif
 
-void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_map) {
-    // First pass: reveal fog-of-war using line-of-sight rays (unchanged)
-    for (int x = 0; x < SCREEN_W; x++) {
-        double cameraX = 2.0 * x / SCREEN_W - 1.0;
-        double rayDirX = player->dir_x + player->plane_x * cameraX;
-        double rayDirY = player->dir_y + player->plane_y * cameraX;
+static void cast_ray(const Maze *maze, double pos_x, double pos_y, double ray_dir_x, double ray_dir_y,
+                     int **reveal, ColumnHit *hit) {
+    int mapX = (int)pos_x;
+    int mapY = (int)pos_y;
 
-        int mapX = (int)player->x;
-        int mapY = (int)player->y;
+    double deltaDistX = (ray_dir_x == 0) ? 1e30 : fabs(1.0 / ray_dir_x);
+    double deltaDistY = (ray_dir_y == 0) ? 1e30 : fabs(1.0 / ray_dir_y);
 
-        double deltaDistX = (rayDirX == 0) ? 1e30 : fabs(1.0 / rayDirX);
-        double deltaDistY = (rayDirY == 0) ? 1e30 : fabs(1.0 / rayDirY);
+    int stepX = (ray_dir_x < 0) ? -1 : 1;
+    int stepY = (ray_dir_y < 0) ? -1 : 1;
 
-        int stepX = (rayDirX < 0) ? -1 : 1;
-        int stepY = (rayDirY < 0) ? -1 : 1;
+    double sideDistX = (ray_dir_x < 0) ? (pos_x - mapX) * deltaDistX : (mapX + 1.0 - pos_x) * deltaDistX;
+    double sideDistY = (ray_dir_y < 0) ? (pos_y - mapY) * deltaDistY : (mapY + 1.0 - pos_y) * deltaDistY;
 
-        double sideDistX = (rayDirX < 0) ? (player->x - mapX) * deltaDistX : (mapX + 1.0 - player->x) * deltaDistX;
-        double sideDistY = (rayDirY < 0) ? (player->y - mapY) * deltaDistY : (mapY + 1.0 - player->y) * deltaDistY;
+    int side = 0;
+    int tile = WALL;
 
-        int hit = 0;
-        while (!hit) {
-            if (sideDistX < sideDistY) {
-                sideDistX += deltaDistX;
-                mapX += stepX;
-            } else {
-                sideDistY += deltaDistY;
-                mapY += stepY;
-            }
+    while (1) {
+        if (sideDistX < sideDistY) {
+            sideDistX += deltaDistX;
+            mapX += stepX;
+            side = 0;
+        } else {
+            sideDistY += deltaDistY;
+            mapY += stepY;
+            side = 1;
+        }
+
+        if (mapX < 0 || mapX >= maze->w || mapY < 0 || mapY >= maze->h) {
+            tile = WALL;
+            break;
+        }
+
+        // Fog-of-war: everything the ray passes through becomes visible
+        if (reveal) {
+            reveal[mapY][mapX] = 1;
+        }
+
+        tile = maze->grid[mapY][mapX];
+        if (tile == WALL || tile == EXIT_TILE || tile == MAP_PIECE) {
+            break;
+        }
+    }
+
+    // Calculate distance to wall
+    double perpWallDist;
+    if (side == 0) {
+        perpWallDist = (mapX - pos_x + (1 - stepX) / 2.0) / ray_dir_x;
+    } else {
+        perpWallDist = (mapY - pos_y + (1 - stepY) / 2.0) / ray_dir_y;
+    }
+
+    hit->map_x = mapX;
+    hit->map_y = mapY;
+    hit->side = side;
+    hit->tile = tile;
+    hit->dist = perpWallDist;
+}
+
+#ifndef MAZE_HEADLESS
+static void cast_columns(Maze *maze, Player *player, ColumnHit *hits) {
+    for (int x = 0; x < SCREEN_W; x++) {
+        double cameraX = 2.0 * x / SCREEN_W - 1.0;
+        double rayDirX = player->dir_x + player->plane_x * cameraX;
+        double rayDirY = player->dir_y + player->plane_y * cameraX;
 
-            if (mapX < 0 || mapX >= maze->w || mapY < 0 || mapY >= maze->h ||
-                maze->grid[mapY][mapX] == WALL || maze->grid[mapY][mapX] == EXIT_TILE ||
-                maze->grid[mapY][mapX] == MAP_PIECE) {
-                hit = 1;
+        cast_ray(maze, player->x, player->y, rayDirX, rayDirY, maze->visited, &hits[x]);
+    }
+}
+#endif
+
+// See maze.h. With -fopenmp the work is split across cameras and columns.
+void render_views(const Maze *maze, const Player *cams, int num_cams, int view_w, int view_h,
+                  unsigned char *out) {
+#ifdef _OPENMP
+    #pragma omp parallel for collapse(2) schedule(static)
+#endif
+    for (int c = 0; c < num_cams; c++) {
+        for (int x = 0; x < view_w; x++) {
+            const Player *cam = &cams[c];
+            double cameraX = 2.0 * x / view_w - 1.0;
+            double rayDirX = cam->dir_x + cam->plane_x * cameraX;
+            double rayDirY = cam->dir_y + cam->plane_y * cameraX;
+
+            ColumnHit hit;
+            cast_ray(maze, cam->x, cam->y, rayDirX, rayDirY, NULL, &hit);
+
+            double perpWallDist = hit.dist;
+            if (perpWallDist < 0.1) perpWallDist = 0.1;
+
+            int lineHeight = (int)(view_h / perpWallDist);
+            int drawStart = -lineHeight / 2 + view_h / 2;
+            int drawEnd   =  lineHeight / 2 + view_h / 2;
+            if (drawStart < 0)      drawStart = 0;
+            if (drawEnd   > view_h) drawEnd   = view_h;
+
+            unsigned char wall;
+            if (hit.tile == EXIT_TILE) {
+                wall = GRAY_EXIT;
+            } else if (hit.tile == MAP_PIECE) {
+                wall = GRAY_MAP_PIECE;
+            } else {
+                wall = (hit.side == 1) ? GRAY_WALL_SHADED : GRAY_WALL_LIT;
             }
 
-            if (mapX >= 0 && mapX < maze->w && mapY >= 0 && mapY < maze->h) {
-                maze->visited[mapY][mapX] = 1;
+            unsigned char *px = out + (size_t)c * view_w * view_h + x;
+            for (int y = 0; y < view_h; y++) {
+                if (y < drawStart) {
+                    px[(size_t)y * view_w] = GRAY_CEILING;
+                } else if (y < drawEnd) {
+                    px[(size_t)y * view_w] = wall;
+                } else {
+                    px[(size_t)y * view_w] = GRAY_FLOOR;
+                }
             }
         }
     }
+}
+
+#ifndef MAZE_HEADLESS
+static void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_map, int recast) {
+    // One DDA pass both reveals fog-of-war and fills the hit buffer. When the
+    // view hasn't moved the previous hits are still exact, so skip it.
+    if (recast) {
+        cast_columns(maze, player, column_hits);
+    }
 
     // ────────────────────────────────────────────────
     // Rendering pass
@@ -444,51 +838,9 @@ void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_ma
 
     // Draw vertical wall strips
     for (int x = 0; x < SCREEN_W; x++) {
-        double cameraX = 2.0 * x / SCREEN_W - 1.0;
-        double rayDirX = player->dir_x + player->plane_x * cameraX;
-        double rayDirY = player->dir_y + player->plane_y * cameraX;
-
-        int mapX = (int)player->x;
-        int mapY = (int)player->y;
-
-        double deltaDistX = (rayDirX == 0) ? 1e30 : fabs(1.0 / rayDirX);
-        double deltaDistY = (rayDirY == 0) ? 1e30 : fabs(1.0 / rayDirY);
-
-        int stepX = (rayDirX < 0) ? -1 : 1;
-        int stepY = (rayDirY < 0) ? -1 : 1;
-
-        double sideDistX = (rayDirX < 0) ? (player->x - mapX) * deltaDistX : (mapX + 1.0 - player->x) * deltaDistX;
-        double sideDistY = (rayDirY < 0) ? (player->y - mapY) * deltaDistY : (mapY + 1.0 - player->y) * deltaDistY;
-
-        int side = 0;
-        int hit = 0;
-
-        while (!hit) {
-            if (sideDistX < sideDistY) {
-                sideDistX += deltaDistX;
-                mapX += stepX;
-                side = 0;
-            } else {
-                sideDistY += deltaDistY;
-                mapY += stepY;
-                side = 1;
-            }
-
-            if (mapX < 0 || mapX >= maze->w || mapY < 0 || mapY >= maze->h ||
-                maze->grid[mapY][mapX] == WALL || maze->grid[mapY][mapX] == EXIT_TILE ||
-                maze->grid[mapY][mapX] == MAP_PIECE) {
-                hit = 1;
-            }
-        }
-
-        // Calculate distance to wall
-        double perpWallDist;
-        if (side == 0) {
-            perpWallDist = (mapX - player->x + (1 - stepX) / 2.0) / rayDirX;
-        } else {
-            perpWallDist = (mapY - player->y + (1 - stepY) / 2.0) / rayDirY;
-        }
+        ColumnHit *hit = &column_hits[x];
 
+        double perpWallDist = hit->dist;
         if (perpWallDist < 0.1) perpWallDist = 0.1;
 
         // Wall height on screen
@@ -509,12 +861,12 @@ void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_ma
         }
 
         // Choose color
-        if (maze->grid[mapY][mapX] == EXIT_TILE) {
+        if (hit->tile == EXIT_TILE) {
             SDL_SetRenderDrawColor(ren, 0, 255, 100, 255);
-        } else if (maze->grid[mapY][mapX] == MAP_PIECE) {
+        } else if (hit->tile == MAP_PIECE) {
             SDL_SetRenderDrawColor(ren, 100, 150, 255, 255);
         } else {
-            Uint8 brightness = (side == 1) ? 140 : 220;
+            Uint8 brightness = (hit->side == 1) ? 140 : 220;
             SDL_SetRenderDrawColor(ren, brightness, brightness, brightness, 255);
         }
 
@@ -528,7 +880,31 @@ void raycast_and_draw(SDL_Renderer *ren, Maze *maze, Player *player, int show_ma
     }
 }
 
-void draw_hud(SDL_Renderer *ren, TTF_Font *font) {
+// True when the rays themselves would differ from the cached hit buffer.
+static int view_moved(ViewCache *view, Maze *maze, Player *player) {
+    return !view->valid ||
+           view->x != player->x || view->y != player->y || view->dir != player->dir ||
+           view->level != current_level ||
+           view->revision != maze->revision;
+}
+
+// Minimap toggle/zoom only change the overlay, not the wall columns.
+static int overlay_changed(ViewCache *view, int show_map) {
+    return view->show_map != show_map || view->zoom != minimap_zoom;
+}
+
+static void view_store(ViewCache *view, Maze *maze, Player *player, int show_map) {
+    view->valid = 1;
+    view->x = player->x;
+    view->y = player->y;
+    view->dir = player->dir;
+    view->show_map = show_map;
+    view->zoom = minimap_zoom;
+    view->level = current_level;
+    view->revision = maze->revision;
+}
+
+static void draw_hud(SDL_Renderer *ren, TTF_Font *font) {
     if (!font) return;
 
     char text[32];
@@ -588,17 +964,13 @@ SDL_Window *win = SDL_CreateWindow("3D Maze - Distant Map Reveals",
 
     Maze maze;
     Room rooms[NUM_ROOMS];
+    init_maze(&maze);
 
     Player player = { .x = 3.5, .y = 3.5, .dir = M_PI / 2.0 };
 
     // First maze + set initial level display
     regenerate_maze(&maze, rooms, &player);
-
-    double fov_half_tan = tan(FOV / 2.0);
-    player.dir_x = cos(player.dir);
-    player.dir_y = sin(player.dir);
-    player.plane_x = -player.dir_y * fov_half_tan;
-    player.plane_y = player.dir_x * fov_half_tan;
+    current_level++;
 
     const double moveSpeed = 3.0;
     const double rotSpeed = 1.8;
@@ -606,10 +978,25 @@ SDL_Window *win = SDL_CreateWindow("3D Maze - Distant Map Reveals",
     int show_map = 0;
     int tab_pressed = 0;
     int quit = 0;
+    int idle = 0;
+    int redraw = 0;
+    ViewCache view = {0};
     SDL_Event e;
 
     while (!quit) {
-        while (SDL_PollEvent(&e)) {
+        // Nothing moved last frame: block until input arrives instead of
+        // spinning on vsync with an identical picture.
+        int have_event;
+        if (idle) {
+            have_event = SDL_WaitEvent(&e);
+            if (!have_event) {
+                printf("SDL_WaitEvent Error: %s\n", SDL_GetError());
+                break;
+            }
+        } else {
+            have_event = SDL_PollEvent(&e);
+        }
+        for (; have_event; have_event = SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT || (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE))
                 quit = 1;
 
@@ -632,6 +1019,11 @@ SDL_Window *win = SDL_CreateWindow("3D Maze - Distant Map Reveals",
 
             if (e.type == SDL_MOUSEMOTION)
                 player.dir += e.motion.xrel * 0.002f * rotSpeed;
+
+            // Window was exposed/resized: contents must be redrawn even if
+            // the view itself is unchanged
+            if (e.type == SDL_WINDOWEVENT)
+                redraw = 1;
         }
 
         int px = (int)(player.x);
@@ -640,12 +1032,14 @@ SDL_Window *win = SDL_CreateWindow("3D Maze - Distant Map Reveals",
             if (maze.grid[py][px] == EXIT_TILE) {
                 printf("EXIT FOUND! Generating new maze...\n");
                 regenerate_maze(&maze, rooms, &player);
+                current_level++;
                 continue;
             }
             if (maze.grid[py][px] == MAP_PIECE) {
                 printf("MAP PIECE FOUND! Revealing distant area...\n");
                 reveal_random_distant_patch(&maze, px, py);
                 maze.grid[py][px] = PATH;
+                maze.revision++;
             }
         }
 
@@ -688,17 +1082,24 @@ SDL_Window *win = SDL_CreateWindow("3D Maze - Distant Map Reveals",
             }
         }
 
-        player.dir_x = cos(player.dir);
-        player.dir_y = sin(player.dir);
-        player.plane_x = -player.dir_y * fov_half_tan;
-        player.plane_y = player.dir_x * fov_half_tan;
+        player_set_dir(&player);
+
+        int moved = view_moved(&view, &maze, &player);
+        if (overlay_changed(&view, show_map))
+            redraw = 1;
+        idle = !moved && !redraw;
+        if (idle) continue;
 
-        raycast_and_draw(ren, &maze, &player, show_map);
+        // Rays only need recasting when the view changed; a plain redraw
+        // reuses the hit buffer from the last frame
+        raycast_and_draw(ren, &maze, &player, show_map, moved);
 
         // Draw HUD on top of everything
        draw_hud(ren, font);
 
         SDL_RenderPresent(ren);
+        view_store(&view, &maze, &player, show_map);
+        redraw = 0;
     }
 
     SDL_SetRelativeMouseMode(SDL_FALSE);
@@ -712,3 +1113,4 @@ SDL_Window *win = SDL_CreateWindow("3D Maze - Distant Map Reveals",
     SDL_Quit();
     return 0;
 }
+#endif
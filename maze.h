@@ -0,0 +1,53 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+// Maze generator and offscreen renderer. Compile maze.c with -DMAZE_HEADLESS
+// to build it without SDL (no window, no main) and link against it.
+
+#define WALL 0
+#define PATH 1
+#define EXIT_TILE 2
+#define MAP_PIECE 3
+
+#define NUM_ROOMS 44
+
+typedef struct {
+    int x, y, w, h;
+} Room;
+
+typedef struct {
+    int **grid;
+    int **visited;
+    int w, h;
+    int revision;   // bumped whenever grid tiles change
+} Maze;
+
+typedef struct {
+    double x, y;
+    double dir;
+    double dir_x, dir_y;
+    double plane_x, plane_y;
+} Player;
+
+// Allocates the tile and fog grids once; regenerate_maze() reuses them for
+// every new level. Pair with free_maze().
+void init_maze(Maze *maze);
+void free_maze(Maze *maze);
+
+// Builds a new level in an init_maze()'d maze, filling rooms (NUM_ROOMS
+// entries) and moving player to the spawn point facing +y. The level
+// counter is left to the caller.
+void regenerate_maze(Maze *maze, Room *rooms, Player *player);
+
+// Derives the camera direction and plane vectors from player->dir.
+void player_set_dir(Player *player);
+
+// Renders one grayscale view per camera into out, laid out as
+// num_cams * view_h * view_w bytes (camera-major, then row, then column).
+// Set each camera's dir and then call player_set_dir() to fill in the
+// direction and plane vectors.
+// The maze is only read, so many threads can share it.
+void render_views(const Maze *maze, const Player *cams, int num_cams, int view_w, int view_h,
+                  unsigned char *out);
+
+#endif